@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    Headless mass-instance benchmark for ZDFAudioProcessor.
+
+    Builds N instances in parallel inside a juce::AudioProcessorGraph
+    (input -> every instance -> output, like N tracks in a session) and reports
+    construction time, prepareToPlay time, resident memory per instance (once
+    constructed and again once prepared) and the cost of the audio callback.
+
+    Usage:
+        ZDFBenchmark [--instances N] [--blocks K] [--block-size B] [--rate SR]
+
+  ==============================================================================
+*/
+
+//Main.cpp
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#if JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_LINUX
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+// Resident set size of this process in bytes (0 where we don't know how to ask)
+static juce::int64 getResidentBytes()
+{
+   #if JUCE_MAC
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS)
+        return (juce::int64) info.resident_size;
+   #elif JUCE_LINUX
+    auto fields = juce::StringArray::fromTokens (juce::File ("/proc/self/statm").loadFileAsString(), false);
+    if (fields.size() > 1)
+        return fields[1].getLargeIntValue() * (juce::int64) sysconf (_SC_PAGESIZE);
+   #endif
+    return 0;
+}
+
+static double secondsSince (juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+static int getIntOption (const juce::ArgumentList& args, juce::StringRef option, int defaultValue)
+{
+    return args.containsOption (option) ? args.getValueForOption (option).getIntValue() : defaultValue;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args (argc, argv);
+
+    const int numInstances = juce::jmax (1, getIntOption (args, "--instances|-n", 300));
+    const int numBlocks    = juce::jmax (1, getIntOption (args, "--blocks|-b", 2000));
+    const int blockSize    = juce::jmax (1, getIntOption (args, "--block-size", 256));
+    const double sampleRate = juce::jmax (8000, getIntOption (args, "--rate", 48000));
+    const int numChannels  = 2;
+
+    using Graph = juce::AudioProcessorGraph;
+    Graph graph;
+    graph.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+
+    auto input  = graph.addNode (std::make_unique<Graph::AudioGraphIOProcessor> (Graph::AudioGraphIOProcessor::audioInputNode));
+    auto output = graph.addNode (std::make_unique<Graph::AudioGraphIOProcessor> (Graph::AudioGraphIOProcessor::audioOutputNode));
+
+//    --- Construction ---
+    const auto rssBefore = getResidentBytes();
+    const auto constructStart = juce::Time::getHighResolutionTicks();
+
+    std::vector<std::unique_ptr<juce::AudioProcessor>> instances;
+    instances.reserve ((size_t) numInstances);
+    for (int i = 0; i < numInstances; ++i)
+        instances.push_back (std::make_unique<ZDFAudioProcessor>());
+
+    const double constructSeconds = secondsSince (constructStart);
+    const auto rssConstructed = getResidentBytes();
+
+//    Wiring is timed separately - that's the graph's cost, not ours
+    const auto wireStart = juce::Time::getHighResolutionTicks();
+    for (auto& instance : instances)
+    {
+        auto node = graph.addNode (std::move (instance), {}, Graph::UpdateKind::none);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            graph.addConnection ({ { input->nodeID, ch }, { node->nodeID, ch } }, Graph::UpdateKind::none);
+            graph.addConnection ({ { node->nodeID, ch }, { output->nodeID, ch } }, Graph::UpdateKind::none);
+        }
+    }
+    graph.rebuild();
+    const double wireSeconds = secondsSince (wireStart);
+
+//    --- prepareToPlay ---
+//    Scratch buffers and oversamplers are only allocated here, so sample the RSS again around it
+    const auto rssWired = getResidentBytes();
+    const auto prepareStart = juce::Time::getHighResolutionTicks();
+    graph.prepareToPlay (sampleRate, blockSize);
+    const double prepareSeconds = secondsSince (prepareStart);
+    const auto rssPrepared = getResidentBytes();
+
+//    --- Callback cost ---
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random rng (1234);
+
+    double totalSeconds = 0.0, worstSeconds = 0.0;
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (ch, i, rng.nextFloat() * 0.5f - 0.25f);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        graph.processBlock (buffer, midi);
+        const double elapsed = secondsSince (start);
+
+        totalSeconds += elapsed;
+        worstSeconds = juce::jmax (worstSeconds, elapsed);
+        midi.clear();
+    }
+
+    graph.releaseResources();
+
+    const double deadline = blockSize / sampleRate;
+    const double meanSeconds = totalSeconds / numBlocks;
+
+    std::cout << "ZDF mass-instance benchmark\n"
+              << "  instances          : " << numInstances << "\n"
+              << "  block size / rate  : " << blockSize << " @ " << sampleRate << " Hz ("
+                                            << deadline * 1.0e3 << " ms deadline)\n"
+              << "  construction       : " << constructSeconds * 1.0e3 << " ms total, "
+                                            << constructSeconds * 1.0e6 / numInstances << " us/instance\n"
+              << "  graph wiring       : " << wireSeconds * 1.0e3 << " ms\n"
+              << "  prepareToPlay      : " << prepareSeconds * 1.0e3 << " ms total, "
+                                            << prepareSeconds * 1.0e6 / numInstances << " us/instance\n"
+              << "  resident memory    : " << (rssConstructed - rssBefore) / numInstances << " bytes/instance constructed, "
+                                            << (rssConstructed - rssBefore + rssPrepared - rssWired) / numInstances << " prepared"
+                                            << (rssBefore == 0 ? " (unavailable on this platform)" : "") << "\n"
+              << "  callback mean/worst: " << meanSeconds * 1.0e3 << " / " << worstSeconds * 1.0e3 << " ms ("
+                                            << 100.0 * meanSeconds / deadline << "% / "
+                                            << 100.0 * worstSeconds / deadline << "% of deadline)\n"
+              << "  per instance       : " << meanSeconds * 1.0e9 / ((double) numInstances * blockSize)
+                                            << " ns/sample-frame" << std::endl;
+
+    return 0;
+}
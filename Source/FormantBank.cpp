@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    Formant (vowel) filter bank: parallel resonant ZDF band-passes, one band
+    per SIMD lane, morphed between vowel presets by a single parameter.
+
+  ==============================================================================
+*/
+
+//FormantBank.cpp
+
+#include "FormantBank.h"
+
+namespace
+{
+    struct Formant { float frequency, gainDb, bandwidth; };
+
+    // Bass voice formants (centre Hz, level dB, bandwidth Hz) - the usual Csound vowel table
+    const Formant vowelTable[FormantBank::numVowels][FormantBank::numFormants] =
+    {
+        { { 600.0f,   0.0f,  60.0f }, { 1040.0f,  -7.0f,  70.0f }, { 2250.0f,  -9.0f, 110.0f }, { 2450.0f,  -9.0f, 120.0f }, { 2750.0f, -20.0f, 130.0f } }, // A
+        { { 400.0f,   0.0f,  40.0f }, { 1620.0f, -12.0f,  80.0f }, { 2400.0f,  -9.0f, 100.0f }, { 2800.0f, -12.0f, 120.0f }, { 3100.0f, -18.0f, 120.0f } }, // E
+        { { 250.0f,   0.0f,  60.0f }, { 1750.0f, -30.0f,  90.0f }, { 2600.0f, -16.0f, 100.0f }, { 3050.0f, -22.0f, 120.0f }, { 3340.0f, -28.0f, 120.0f } }, // I
+        { { 400.0f,   0.0f,  40.0f }, {  750.0f, -11.0f,  80.0f }, { 2400.0f, -21.0f, 100.0f }, { 2600.0f, -20.0f, 120.0f }, { 2900.0f, -40.0f, 120.0f } }, // O
+        { { 350.0f,   0.0f,  40.0f }, {  600.0f, -20.0f,  80.0f }, { 2400.0f, -32.0f, 100.0f }, { 2675.0f, -28.0f, 120.0f }, { 2950.0f, -36.0f, 120.0f } }  // U
+    };
+}
+
+//==============================================================================
+void FormantBank::prepare (double sampleRate)
+{
+    for (int v = 0; v < numVowels; ++v)
+    {
+        alignas (Vec) float a[numRegisters * Vec::size()], ak[numRegisters * Vec::size()];
+        alignas (Vec) float invDet[numRegisters * Vec::size()], gain[numRegisters * Vec::size()];
+
+        for (int band = 0; band < numRegisters * (int) Vec::size(); ++band)
+        {
+            // Unused lanes: a = 0 keeps them silent and 1/Det = 1 keeps them finite
+            a[band] = ak[band] = gain[band] = 0.0f;
+            invDet[band] = 1.0f;
+
+            if (band >= numFormants)
+                continue;
+
+            const auto& f = vowelTable[v][band];
+//            Prewarped integrator gain, so the peak lands on the table frequency at any sample rate
+            const double fc = juce::jmin ((double) f.frequency, 0.49 * sampleRate);
+            const double g = std::tan (juce::MathConstants<double>::pi * fc / sampleRate);
+            const double k = (double) f.bandwidth / fc; // 1/Q
+
+            a[band] = (float) g;
+            ak[band] = (float) (g * k);
+            invDet[band] = (float) (1.0 / (1.0 + g * k + g * g));
+//            The band-pass state peaks at 1/k, so fold k into the level to get the table gain at the centre
+            gain[band] = (float) (juce::Decibels::decibelsToGain ((double) f.gainDb) * k);
+        }
+
+        auto& t = vowelTargets[v];
+        for (int r = 0; r < numRegisters; ++r)
+        {
+            t.a[r]      = Vec::fromRawArray (a      + r * (int) Vec::size());
+            t.ak[r]     = Vec::fromRawArray (ak     + r * (int) Vec::size());
+            t.invDet[r] = Vec::fromRawArray (invDet + r * (int) Vec::size());
+            t.gain[r]   = Vec::fromRawArray (gain   + r * (int) Vec::size());
+        }
+    }
+
+    current = vowelTargets[0];
+    currentVowel = 0.0f;
+    currentMix = 0.0f;
+    primed = false;
+    reset();
+}
+
+void FormantBank::reset() noexcept
+{
+    for (int channel = 0; channel < 2; ++channel)
+        reset (channel);
+}
+
+void FormantBank::reset (int channel) noexcept
+{
+    auto& st = state[channel];
+    for (int r = 0; r < numRegisters; ++r)
+    {
+        st.bp[r] = Vec::expand (0.0f);
+        st.lp[r] = Vec::expand (0.0f);
+    }
+    st.xPrev = 0.0f;
+}
+
+bool FormantBank::isStateFinite (int channel) const noexcept
+{
+    const auto& st = state[channel];
+    auto total = Vec::expand (st.xPrev);
+    for (int r = 0; r < numRegisters; ++r)
+        total += st.bp[r] + st.lp[r];
+    return std::isfinite (total.sum());
+}
+
+FormantBank::Vec FormantBank::reciprocalDeterminant (Vec a, Vec ak) noexcept
+{
+    alignas (Vec) float lanes[Vec::size()];
+    (Vec::expand (1.0f) + ak + a * a).copyToRawArray (lanes);
+    for (auto& lane : lanes)
+        lane = 1.0f / lane;
+    return Vec::fromRawArray (lanes);
+}
+
+FormantBank::Coefficients FormantBank::morphTo (float vowel) const noexcept
+{
+    vowel = juce::jlimit (0.0f, (float) (numVowels - 1), vowel);
+    const int lower = juce::jmin ((int) vowel, numVowels - 2);
+    const float frac = vowel - (float) lower;
+
+    const auto& c0 = vowelTargets[lower];
+    const auto& c1 = vowelTargets[lower + 1];
+
+    Coefficients c;
+    for (int r = 0; r < numRegisters; ++r)
+    {
+        c.a[r]    = c0.a[r]    + (c1.a[r]    - c0.a[r])    * frac;
+        c.ak[r]   = c0.ak[r]   + (c1.ak[r]   - c0.ak[r])   * frac;
+        c.gain[r] = c0.gain[r] + (c1.gain[r] - c0.gain[r]) * frac;
+//        1/Det isn't linear in a and ak, so lerping it between vowels would mistune the damping - derive it
+        c.invDet[r] = reciprocalDeterminant (c.a[r], c.ak[r]);
+    }
+    return c;
+}
+
+//==============================================================================
+void FormantBank::process (juce::AudioBuffer<float>& buffer, float vowel, float mix) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = juce::jmin (buffer.getNumChannels(), 2);
+    if (numSamples == 0)
+        return;
+
+    vowel = juce::jlimit (0.0f, (float) (numVowels - 1), vowel);
+    const Coefficients target = morphTo (vowel);
+//    First block after prepare: start on the target instead of sweeping in from vowel A
+    if (! primed)
+    {
+        current = target;
+        currentVowel = vowel;
+        primed = true;
+    }
+
+//    Per-sample coefficient increments so a vowel move never steps mid-block. 1/Det is rederived from
+//    the ramped a and ak while the vowel moves; held still, every sample already has the exact value.
+    const bool morphing = vowel != currentVowel;
+    const float step = 1.0f / (float) numSamples;
+    Coefficients inc;
+    for (int r = 0; r < numRegisters; ++r)
+    {
+        inc.a[r]    = (target.a[r]    - current.a[r])    * step;
+        inc.ak[r]   = (target.ak[r]   - current.ak[r])   * step;
+        inc.gain[r] = (target.gain[r] - current.gain[r]) * step;
+    }
+    const float mixInc = (mix - currentMix) * step;
+    const auto one = Vec::expand (1.0f);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* data = buffer.getWritePointer (channel);
+        auto& st = state[channel];
+        Coefficients c = current;
+        float wet = currentMix;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = data[i];
+            const auto xSum = Vec::expand (x + st.xPrev);
+            auto out = Vec::expand (0.0f);
+
+            for (int r = 0; r < numRegisters; ++r)
+            {
+                c.a[r] += inc.a[r];
+                c.ak[r] += inc.ak[r];
+                c.gain[r] += inc.gain[r];
+                if (morphing)
+                    c.invDet[r] = reciprocalDeterminant (c.a[r], c.ak[r]);
+
+                const auto a = c.a[r];
+
+                // Trapezoidal band-pass/low-pass pair: bp' = wc(x - k bp - lp), lp' = wc bp
+//                Right hand sides from the previous states and inputs
+                const auto E = st.bp[r] * (one - c.ak[r]) - a * st.lp[r] + a * xSum;
+                const auto F = st.lp[r] + a * st.bp[r];
+
+//                A = 1 + ak, B = a, C = -a, D = 1 - solved per lane with 1/Det from the coefficient set
+                const auto bp = (E - a * F) * c.invDet[r];
+                const auto lp = ((one + c.ak[r]) * F + a * E) * c.invDet[r];
+
+                st.bp[r] = bp;
+                st.lp[r] = lp;
+                out += bp * c.gain[r];
+            }
+
+            st.xPrev = x;
+            wet += mixInc;
+            data[i] = x + wet * (out.sum() - x);
+        }
+    }
+
+    current = target;
+    currentVowel = vowel;
+    currentMix = mix;
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    Formant (vowel) filter bank: parallel resonant ZDF band-passes, one band
+    per SIMD lane, morphed between vowel presets by a single parameter.
+
+  ==============================================================================
+*/
+
+//FormantBank.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Each band is a trapezoidal 2-pole band-pass solved the same way as the main
+    filter (right hand sides E/F, coefficient matrix A,B,C,D and its determinant),
+    except every quantity is a SIMD register holding one band per lane. The whole
+    bank therefore costs roughly one scalar 2-pole per register.
+*/
+class FormantBank
+{
+public:
+    static constexpr int numVowels = 5;   // A, E, I, O, U
+    static constexpr int numFormants = 5; // formants per vowel in the table
+    static constexpr int maxBands = 8;    // lanes reserved per channel - room for up to 8 formants
+
+    // Builds the per-vowel coefficient targets for this sample rate and clears the state
+    void prepare (double sampleRate);
+    void reset() noexcept;
+    void reset (int channel) noexcept;
+
+    // Filters every channel of the buffer in place. vowel runs 0..numVowels-1 (A..U) and is morphed
+    // continuously; mix crossfades dry -> bank. Both are ramped over the block from the previous call.
+    void process (juce::AudioBuffer<float>& buffer, float vowel, float mix) noexcept;
+
+    bool isStateFinite (int channel) const noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int numRegisters = (int) ((maxBands + Vec::size() - 1) / Vec::size());
+
+    // Lane-parallel coefficients: integrator gain a, damping term a*k, 1/Det and output gain (k folded in)
+    struct Coefficients
+    {
+        Vec a[numRegisters], ak[numRegisters], invDet[numRegisters], gain[numRegisters];
+    };
+
+    struct ChannelState
+    {
+        Vec bp[numRegisters], lp[numRegisters];
+        float xPrev = 0.0f;
+    };
+
+    Coefficients morphTo (float vowel) const noexcept;
+    // 1/(1 + ak + a^2) per lane - SIMDRegister has no divide, so this goes through a scalar loop
+    static Vec reciprocalDeterminant (Vec a, Vec ak) noexcept;
+
+    Coefficients vowelTargets[numVowels];
+    Coefficients current;
+    float currentVowel = 0.0f;
+    ChannelState state[2];
+    float currentMix = 0.0f;
+    bool primed = false;
+
+    JUCE_LEAK_DETECTOR (FormantBank)
+};
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    Fixed pool of per-note ADSR envelopes driving the filter cutoff from MIDI.
+
+  ==============================================================================
+*/
+
+//NoteEnvelopePool.cpp
+
+#include "NoteEnvelopePool.h"
+
+//==============================================================================
+void NoteEnvelopePool::prepare (double sampleRate)
+{
+    for (auto& slot : slots)
+        slot.adsr.setSampleRate (sampleRate);
+
+    reset();
+}
+
+void NoteEnvelopePool::reset() noexcept
+{
+    for (auto& slot : slots)
+    {
+        slot.adsr.reset();
+        slot.note = -1;
+        slot.held = false;
+        slot.order = 0;
+        slot.level = 0.0f;
+    }
+    noteCounter = 0;
+}
+
+void NoteEnvelopePool::setParameters (const juce::ADSR::Parameters& params) noexcept
+{
+    for (auto& slot : slots)
+        slot.adsr.setParameters (params);
+}
+
+//==============================================================================
+void NoteEnvelopePool::handleMidiMessage (const juce::MidiMessage& message) noexcept
+{
+    if (message.isNoteOn())
+        noteOn (message.getNoteNumber());
+    else if (message.isNoteOff())
+        noteOff (message.getNoteNumber());
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+        allNotesOff();
+}
+
+void NoteEnvelopePool::noteOn (int note) noexcept
+{
+//    Same note again retriggers its own slot, otherwise take a free one, otherwise steal the oldest
+    Slot* target = nullptr;
+    for (auto& slot : slots)
+        if (slot.note == note && slot.adsr.isActive())
+            target = &slot;
+
+    if (target == nullptr)
+        for (auto& slot : slots)
+            if (! slot.adsr.isActive())
+            {
+                target = &slot;
+                break;
+            }
+
+    if (target == nullptr)
+    {
+        target = &slots[0];
+        for (auto& slot : slots)
+            if (slot.order < target->order)
+                target = &slot;
+
+        target->adsr.reset();
+        target->level = 0.0f;
+    }
+
+    target->note = note;
+    target->held = true;
+    target->order = ++noteCounter;
+    target->adsr.noteOn();
+    lastNote = note;
+}
+
+void NoteEnvelopePool::noteOff (int note) noexcept
+{
+    for (auto& slot : slots)
+        if (slot.note == note && slot.held)
+        {
+            slot.held = false;
+            slot.adsr.noteOff();
+        }
+}
+
+void NoteEnvelopePool::allNotesOff() noexcept
+{
+    for (auto& slot : slots)
+        if (slot.held)
+        {
+            slot.held = false;
+            slot.adsr.noteOff();
+        }
+}
+
+//==============================================================================
+void NoteEnvelopePool::advance (int numSamples) noexcept
+{
+    for (auto& slot : slots)
+    {
+        if (! slot.adsr.isActive())
+            continue;
+
+        for (int i = 0; i < numSamples; ++i)
+            slot.level = slot.adsr.getNextSample();
+
+        if (! slot.adsr.isActive())
+            slot.level = 0.0f;
+    }
+}
+
+const NoteEnvelopePool::Slot* NoteEnvelopePool::findModulatingSlot() const noexcept
+{
+    const Slot* newestHeld = nullptr;
+    const Slot* newestActive = nullptr;
+
+    for (auto& slot : slots)
+    {
+        if (! slot.adsr.isActive())
+            continue;
+
+        if (newestActive == nullptr || slot.order > newestActive->order)
+            newestActive = &slot;
+
+        if (slot.held && (newestHeld == nullptr || slot.order > newestHeld->order))
+            newestHeld = &slot;
+    }
+
+    return newestHeld != nullptr ? newestHeld : newestActive;
+}
+
+int NoteEnvelopePool::getModulationNote() const noexcept
+{
+    if (auto* slot = findModulatingSlot())
+        return slot->note;
+
+    return lastNote;
+}
+
+float NoteEnvelopePool::getModulationLevel() const noexcept
+{
+    if (auto* slot = findModulatingSlot())
+        return slot->level;
+
+    return 0.0f;
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    Fixed pool of per-note ADSR envelopes driving the filter cutoff from MIDI.
+
+  ==============================================================================
+*/
+
+//NoteEnvelopePool.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Every note gets its own envelope slot, but the filter only has one cutoff, so
+    modulation follows the most recently pressed note that is still held (falling
+    back to the newest note still in its release). All slots live in a fixed array,
+    so a burst of notes never allocates on the audio thread - when the pool is full
+    the oldest slot is stolen.
+*/
+class NoteEnvelopePool
+{
+public:
+    static constexpr int numSlots = 16;
+
+    void prepare (double sampleRate);
+    void reset() noexcept;
+    void setParameters (const juce::ADSR::Parameters& params) noexcept;
+
+    void handleMidiMessage (const juce::MidiMessage& message) noexcept;
+
+    // Runs every sounding envelope forward by numSamples
+    void advance (int numSamples) noexcept;
+
+    // Note number and envelope level the cutoff should follow right now. With nothing sounding
+    // the last note played is kept (so keytracking doesn't jump when a release ends) with a level of 0.
+    int getModulationNote() const noexcept;
+    float getModulationLevel() const noexcept;
+
+private:
+    struct Slot
+    {
+        juce::ADSR adsr;
+        int note = -1;
+        bool held = false;
+        juce::uint32 order = 0;   // when it was last triggered, for note priority and stealing
+        float level = 0.0f;       // last value the envelope produced
+    };
+
+    void noteOn (int note) noexcept;
+    void noteOff (int note) noexcept;
+    void allNotesOff() noexcept;
+    const Slot* findModulatingSlot() const noexcept;
+
+    Slot slots[numSlots];
+    juce::uint32 noteCounter = 0;
+    int lastNote = 60;
+
+    JUCE_LEAK_DETECTOR (NoteEnvelopePool)
+};
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    Worker pool shared by every ZDF instance in the process, used for
+    parallel-in-time rendering during offline bounces.
+
+  ==============================================================================
+*/
+
+//OfflineRenderPool.h
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Held through a juce::SharedResourcePointer, so the threads are created when the
+    first instance is prepared for an offline render and go away with the last one.
+*/
+class OfflineRenderPool
+{
+public:
+    OfflineRenderPool() : pool (juce::jmax (1, juce::SystemStats::getNumCpus() - 1)) {}
+
+    int getNumWorkers() const { return pool.getNumThreads(); }
+
+    //==============================================================================
+    /**
+        Everything one caller needs for a parallelFor, allocated up front in prepare() so
+        running a batch on the audio thread doesn't touch the heap. Each instance owns its
+        own, which keeps concurrent bounces of several instances out of each other's way.
+    */
+    class Batch
+    {
+    public:
+        Batch() = default;
+
+        // One helper job per pool worker. parallelFor only returns once the pool has let go of every
+        // helper, so these are safe to call (and the Batch safe to destroy) whenever none is running.
+        void prepare (int numWorkers)
+        {
+            helpers.clear();
+            for (int h = 0; h < numWorkers; ++h)
+                helpers.push_back (std::make_unique<Helper> (*this));
+        }
+
+        void release() { helpers.clear(); }
+
+    private:
+        friend class OfflineRenderPool;
+
+        struct Helper : public juce::ThreadPoolJob
+        {
+            explicit Helper (Batch& b) : juce::ThreadPoolJob ("ZDF offline render"), batch (b) {}
+
+            JobStatus runJob() override
+            {
+                batch.work();
+                return jobHasFinished;
+            }
+
+            Batch& batch;
+        };
+
+        void work()
+        {
+            for (int i = next.fetch_add (1); i < numTasks; i = next.fetch_add (1))
+                invoke (context, i);
+        }
+
+        std::vector<std::unique_ptr<Helper>> helpers;
+        void (*invoke) (void*, int) = nullptr;              // type-erased task, so no std::function to allocate
+        void* context = nullptr;
+        int numTasks = 0;
+        std::atomic<int> next { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (Batch)
+    };
+
+    // Runs task (0) ... task (numTasks - 1) and returns once all of them have finished.
+    // The calling thread works through tasks too, so this never blocks on an idle pool.
+    template <typename Task>
+    void parallelFor (Batch& batch, int numTasks, Task&& task)
+    {
+        if (numTasks <= 0)
+            return;
+
+        using TaskType = std::remove_reference_t<Task>;
+        batch.invoke = [] (void* context, int i) { (*static_cast<TaskType*> (context)) (i); };
+        batch.context = const_cast<void*> (static_cast<const void*> (std::addressof (task)));
+        batch.numTasks = numTasks;
+        batch.next = 0;
+
+        const int numHelpers = juce::jmin (numTasks - 1, (int) batch.helpers.size());
+        for (int h = 0; h < numHelpers; ++h)
+            pool.addJob (batch.helpers[(size_t) h].get(), false);
+
+        batch.work();
+
+        // Wait until the pool has removed each helper, not just until its runJob() returned - the pool still
+        // holds the job for a moment afterwards, and the next call re-adds the same job objects
+        for (int h = 0; h < numHelpers; ++h)
+            pool.waitForJobToFinish (batch.helpers[(size_t) h].get(), -1);
+    }
+
+private:
+    juce::ThreadPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderPool)
+};
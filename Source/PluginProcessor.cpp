@@ -21,22 +21,41 @@ ZDFAudioProcessor::ZDFAudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       ), apvts(*this, nullptr, "PARAMETERS", {
-         std::make_unique<juce::AudioParameterFloat>("cutoff", "Cutoff", 20.0f, 20000.0f, 1000.0f),
-         std::make_unique<juce::AudioParameterFloat>("resonance", "Resonance", 0.0f, 1.0f, 0.5f),
-         std::make_unique<juce::AudioParameterFloat>("hpCutoff", "HP Cutoff", 20.0f, 20000.0f, 200.0f),
-         std::make_unique<juce::AudioParameterFloat>("drive", "Drive", 0.0f, 2.0f, 0.5f)
-                        })
+                       ), apvts(*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
 {
-    // Initialize states to 0
-    for (int c = 0; c < 2; ++c)
-    {
-        vPrev[c]  = 0.0;
-        xPrev[c]  = 0.0;
-        vPrev2[c] = 0.0;
-        xPrev2[c] = 0.0;
-    }
+    cutoffParam    = apvts.getRawParameterValue("cutoff");
+    resonanceParam = apvts.getRawParameterValue("resonance");
+    hpCutoffParam  = apvts.getRawParameterValue("hpCutoff");
+    driveParam     = apvts.getRawParameterValue("drive");
+    vowelParam     = apvts.getRawParameterValue("vowel");
+    formantMixParam = apvts.getRawParameterValue("formantMix");
+    keytrackParam   = apvts.getRawParameterValue("keytrack");
+    envAmountParam  = apvts.getRawParameterValue("envAmount");
+    envAttackParam  = apvts.getRawParameterValue("envAttack");
+    envDecayParam   = apvts.getRawParameterValue("envDecay");
+    envSustainParam = apvts.getRawParameterValue("envSustain");
+    envReleaseParam = apvts.getRawParameterValue("envRelease");
+    cpuBudgetParam  = apvts.getRawParameterValue("cpuBudget");
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout ZDFAudioProcessor::createParameterLayout()
+{
+    return {
+        std::make_unique<juce::AudioParameterFloat>("cutoff", "Cutoff", 20.0f, 20000.0f, 1000.0f),
+        std::make_unique<juce::AudioParameterFloat>("resonance", "Resonance", 0.0f, 1.0f, 0.5f),
+        std::make_unique<juce::AudioParameterFloat>("hpCutoff", "HP Cutoff", 20.0f, 20000.0f, 200.0f),
+        std::make_unique<juce::AudioParameterFloat>("drive", "Drive", 0.0f, 2.0f, 0.5f),
+        std::make_unique<juce::AudioParameterFloat>("vowel", "Vowel", 0.0f, (float) (FormantBank::numVowels - 1), 0.0f),
+        std::make_unique<juce::AudioParameterFloat>("formantMix", "Formant Mix", 0.0f, 1.0f, 0.0f),
+        std::make_unique<juce::AudioParameterFloat>("keytrack", "Keytrack", 0.0f, 1.0f, 0.0f),
+        std::make_unique<juce::AudioParameterFloat>("envAmount", "Env Amount (oct)", -4.0f, 4.0f, 0.0f),
+        std::make_unique<juce::AudioParameterFloat>("envAttack", "Env Attack (ms)", 0.0f, 5000.0f, 5.0f),
+        std::make_unique<juce::AudioParameterFloat>("envDecay", "Env Decay (ms)", 1.0f, 5000.0f, 200.0f),
+        std::make_unique<juce::AudioParameterFloat>("envSustain", "Env Sustain", 0.0f, 1.0f, 0.5f),
+        std::make_unique<juce::AudioParameterFloat>("envRelease", "Env Release (ms)", 1.0f, 10000.0f, 300.0f),
+        std::make_unique<juce::AudioParameterFloat>("cpuBudget", "CPU Budget (% of block)", 1.0f, 100.0f, 25.0f)
+    };
 }
 
 ZDFAudioProcessor::~ZDFAudioProcessor()
@@ -109,17 +128,89 @@ void ZDFAudioProcessor::changeProgramName (int index, const juce::String& newNam
 void ZDFAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     sr = sampleRate;
+
+//    Quality tier follows the host mode: the offline tier oversamples (set up here, since it changes latency
+//    and allocates); realtime runs at 1x with no added latency, so tracking stays as direct as possible.
+//    Hosts compensate with the latency reported for the mode they prepared, and the FIR half-band filters
+//    keep that latency a whole number of samples. The saturation crossfade is reset, so the new tier starts
+//    fully on its own kernels.
+    if (isNonRealtime())
+    {
+        oversamplingFactor = 1 << offlineOversamplingOrder;
+        oversampling = std::make_unique<juce::dsp::Oversampling<float>> (2, offlineOversamplingOrder,
+                                                                        juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+                                                                        true, true);
+        oversampling->initProcessing ((size_t) juce::jmax (1, samplesPerBlock));
+        oversamplingBlockSize = juce::jmax (1, samplesPerBlock);
+        setLatencySamples (juce::roundToInt (oversampling->getLatencyInSamples()));
+        qualityTier.store (QualityTier::offline, std::memory_order_relaxed);
+    }
+    else
+    {
+        oversamplingFactor = 1;
+        oversampling.reset();
+        oversamplingBlockSize = 0;
+        setLatencySamples (0);
+        qualityTier.store (QualityTier::standard, std::memory_order_relaxed);
+    }
+    saturation = Saturation{};
+    samplesSinceTierChange = 0;
+    cpuLoad.store (0.0f, std::memory_order_relaxed);
+
+    formantBank.prepare (sampleRate);
+    noteEnvelopes.prepare (sampleRate);
+
+    unrolledCapacity = samplesPerBlock * oversamplingFactor;
+    unrolledScratch.assign ((size_t) (2 * unrolledCapacity), 0.0);
+    unrolled = UnrolledCoefficients{};
+    formantActive = false;
+
+//    The parallel offline path only exists for instances the host prepares for a bounce, so realtime
+//    instances pay nothing for it. The worker pool itself is shared by every instance in the process.
+    if (isNonRealtime())
+    {
+        if (! offlinePool.has_value())
+            offlinePool.emplace();
+
+        maxOfflineChunks = juce::jmax (1, (*offlinePool)->getNumWorkers() + 1);
+        offlineBatch.prepare ((*offlinePool)->getNumWorkers());
+        offlineBlockCapacity = samplesPerBlock * oversamplingFactor;
+        offlineScratch.assign ((size_t) (4 * offlineBlockCapacity), 0.0);
+        offlineChunks.assign ((size_t) (2 * maxOfflineChunks), ChunkBoundary{});
+    }
+    else
+    {
+        offlineBatch.release();
+        offlinePool.reset();
+        offlineBlockCapacity = 0;
+        offlineScratch = {};
+        offlineChunks = {};
+    }
+//    ~10 ms fade-in after a NaN/Inf reset
+    fadeInLength = juce::jmax (1, (int) (sr * 0.01));
     for (int i = 0; i < 2; ++i)
     {
-        vPrev[i] = 0.0;
-        xPrev[i] = 0.0;
-        vPrev2[i] = 0.0;
-        xPrev2[i] = 0.0;
-        vHP[i] = 0.0;
-        xHP[i] = 0.0;
+        resetChannelState (i);
+        hot.fadeInRemaining[i] = 0;
     }
 }
 
+void ZDFAudioProcessor::resetChannelState (int channel) noexcept
+{
+    hot.channels[channel] = ChannelState{};
+}
+
+double ZDFAudioProcessor::clampResonanceForStability (double R, double a) noexcept
+{
+//    The update matrix Phi = M^-1 N (M = [[1+a, -aR], [-a, 1+a]], N = [[1-a, 0], [a, 1-a]]) has characteristic
+//    polynomial ((1+a)^2 - a^2 R) z^2 - (2(1+a)(1-a) + a^2 R) z + (1-a)^2. The Jury test puts both poles inside
+//    the unit circle iff R < 2 and R < 4/a. The second bound only bites when cutoff is close to (or above)
+//    Nyquist, i.e. at low sample rates, so it has to be recomputed from a rather than baked in.
+    const double margin = 0.98;
+    const double rMax = margin * juce::jmin (2.0, 4.0 / juce::jmax (a, 1.0e-9));
+    return juce::jmin (R, rMax);
+}
+
 void ZDFAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
@@ -152,11 +243,10 @@ bool ZDFAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) cons
 }
 #endif
 
-void ZDFAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void ZDFAudioProcessor::processFilterSegment (juce::AudioBuffer<float>& buffer, float currentCutoff, float param,
+                                              float hpCutoff, float drive)
 {
 //    --- Low-Pass Parameters ----
-    float currentCutoff = *apvts.getRawParameterValue("cutoff");
-    float param = *apvts.getRawParameterValue("resonance");
 //    Log scale the Q value for smoother resonance responce
     double Q = std::exp(std::log(100.0)*param); // Q=1 at param=0, Q=100 at param=1
 //   Calculate resonance based on the (currently not well-functioning) Q value to better emphasize cutoff freq
@@ -164,38 +254,246 @@ void ZDFAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mi
     R *= 1.8; // scale as needed
 //        Convert cutoff frequency to angular frequency - radians per second - the preferred nomenclature of the following filter formulae
     wc = 2.0 * juce::MathConstants<double>::pi * (double)currentCutoff;
-//    Determine the sampling period
-    double T = 1.0 / sr;
+//    Determine the sampling period (at the oversampled rate when the tier oversamples)
+    double T = 1.0 / (sr * oversamplingFactor);
 //   Coefficient for trapezoidal integration - essential for the linear equations below
     double a = (T * wc) / 2.0;
-    
-    // driveParam: how much to push the signal into the tanh saturation
-    float driveParam = *apvts.getRawParameterValue("drive");
+//    Keep the resonance inside the filter's stability region for this cutoff/sample rate
+    R = clampResonanceForStability (R, a);
     
 //   ----- High-Pass Parameters -----
-    float hpCutoff = *apvts.getRawParameterValue("hpCutoff");
     double wcHP = 2.0 * juce::MathConstants<double>::pi * (double)hpCutoff;
     double aHP = (T * wcHP) / 2.0;
+//   Drive gain is constant over the block - no need for a pow() per sample
+    saturation.gain = std::pow(10.0, drive * 0.5);
 
     
+//   Get samples from the buffer
+    const int numSamples = buffer.getNumSamples();
+
+//    Offline bounce with parameters that haven't moved since the last block: split the block in time and
+//    across channels over the shared worker pool. Anything else (realtime, automation, an oversized block) runs serially,
+//    and so does a block too short for two time chunks - splitting channels alone doesn't pay for the four barriers.
+    const float paramValues[4] = { currentCutoff, param, hpCutoff, drive };
+    const bool paramsSteady = std::equal (std::begin (paramValues), std::end (paramValues), std::begin (lastParamValues));
+    std::copy (std::begin (paramValues), std::end (paramValues), std::begin (lastParamValues));
+
+    const int numChunks = offlinePool.has_value()
+                        ? juce::jlimit (1, maxOfflineChunks, numSamples / minOfflineChunkLength)
+                        : 1;
+
+    if (isNonRealtime() && offlinePool.has_value() && paramsSteady && ! saturation.isCrossfading()
+         && numSamples <= offlineBlockCapacity && numSamples >= 2 * minOfflineChunkLength)
+        processParallelInTime (buffer, a, R, aHP, saturation, numChunks);
+    else if (numSamples <= unrolledCapacity)
+        processUnrolled (buffer, a, R, aHP, saturation);
+    else
+        processSerial (buffer, a, R, aHP, saturation);
+
+    saturation.advance (numSamples);
+}
+
+void ZDFAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    const auto callbackStart = juce::Time::getHighResolutionTicks();
+
+    const float cutoff = cutoffParam->load();
+    const float resonance = resonanceParam->load();
+    const float hpCutoff = hpCutoffParam->load();
+    // drive: how much to push the signal into the tanh saturation
+    const float drive = driveParam->load();
+
 //   Get samples from the buffer
     const int numSamples = buffer.getNumSamples();
     const int numChannels = buffer.getNumChannels();
 //    Ensure that we are operating in stereo
     jassert(numChannels <= 2);
+
+//    --- MIDI keytracking / note envelope ---
+//    The block is split at every MIDI event so notes take effect on their exact sample. While keytracking or
+//    the envelope is in use, segments are also capped at modulationInterval so the cutoff follows the envelope.
+    noteEnvelopes.setParameters ({ envAttackParam->load() * 0.001f, envDecayParam->load() * 0.001f,
+                                   envSustainParam->load(), envReleaseParam->load() * 0.001f });
+    const float keytrack = keytrackParam->load();
+    const float envAmount = envAmountParam->load();
+    const bool modulating = keytrack != 0.0f || envAmount != 0.0f;
+    const int maxSegmentLength = modulating ? modulationInterval : numSamples;
+
+//    The filter runs on the oversampled signal when the tier asks for it; everything else stays at the host rate.
+//    The oversampler only has buffers for the block size it was prepared with, so a host that sends a larger
+//    block gets it filtered in prepared-size pieces.
+    const int subBlockLength = oversampling != nullptr ? oversamplingBlockSize : numSamples;
+    juce::dsp::AudioBlock<float> fullBlock (buffer);
+
+    auto midiIt = midiMessages.begin();
+    for (int subStart = 0; subStart < numSamples; subStart += subBlockLength)
+    {
+        const int subEnd = juce::jmin (numSamples, subStart + subBlockLength);
+        auto hostBlock = fullBlock.getSubBlock ((size_t) subStart, (size_t) (subEnd - subStart));
+
+        float* filterChannels[2] = {};
+        if (oversampling != nullptr)
+        {
+            auto upBlock = oversampling->processSamplesUp (hostBlock);
+            for (int channel = 0; channel < numChannels; ++channel)
+                filterChannels[channel] = upBlock.getChannelPointer ((size_t) channel);
+        }
+        else
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                filterChannels[channel] = hostBlock.getChannelPointer ((size_t) channel);
+        }
+
+        for (int pos = subStart; pos < subEnd;)
+        {
+            for (; midiIt != midiMessages.end() && (*midiIt).samplePosition <= pos; ++midiIt)
+                noteEnvelopes.handleMidiMessage ((*midiIt).getMessage());
+
+            const int nextEvent = midiIt != midiMessages.end() ? juce::jmin ((*midiIt).samplePosition, subEnd) : subEnd;
+            const int length = juce::jmin (nextEvent - pos, maxSegmentLength);
+
+//            Cutoff for this segment: semitones from middle C scaled by keytrack, plus envAmount octaves of envelope
+            float segmentCutoff = cutoff;
+            if (modulating)
+            {
+                const float octaves = (float) (noteEnvelopes.getModulationNote() - 60) * keytrack / 12.0f
+                                    + noteEnvelopes.getModulationLevel() * envAmount;
+                segmentCutoff = juce::jlimit (20.0f, (float) (0.45 * sr), cutoff * std::exp2 (octaves));
+            }
+
+//            Refers to the (possibly oversampled) channels in place - no allocation
+            juce::AudioBuffer<float> segment (filterChannels, numChannels, (pos - subStart) * oversamplingFactor,
+                                              length * oversamplingFactor);
+            processFilterSegment (segment, segmentCutoff, resonance, hpCutoff, drive);
+
+            noteEnvelopes.advance (length);
+            pos += length;
+        }
+
+        if (oversampling != nullptr)
+            oversampling->processSamplesDown (hostBlock);
+    }
+
+//    Anything stamped at or past the end of the block (or every event of an empty block)
+    for (; midiIt != midiMessages.end(); ++midiIt)
+        noteEnvelopes.handleMidiMessage ((*midiIt).getMessage());
+
+//    Formant bank on the filter output (costs nothing while the mix is at 0)
+    const float formantMix = formantMixParam->load();
+    if (formantMix > 0.0f || formantActive)
+    {
+        if (! formantActive)
+            formantBank.reset();
+
+        formantBank.process (buffer, vowelParam->load(), formantMix);
+    }
+    formantActive = formantMix > 0.0f;
+
+//    NaN/Inf guard - checked once per block rather than per sample. A single sum is enough since any
+//    non-finite term (or an overflow) makes it non-finite. If it trips, this block is silenced,
+//    the channel is reset and the next blocks fade back in.
+    bool tripped[2] = { false, false };
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const ChannelState& st = hot.channels[channel];
+        tripped[channel] = ! std::isfinite (st.vPrev + st.xPrev + st.vPrev2 + st.xPrev2 + st.vHP + st.xHP)
+                           || (formantActive && ! formantBank.isStateFinite (channel));
+    }
+
+//    The oversampler can only be reset as a whole, so a healthy channel loses its filter history too:
+//    ramp it out over this block and fade it back in like the channel that tripped
+    const bool resetOversampler = oversampling != nullptr && (tripped[0] || tripped[1]);
+    if (resetOversampler)
+        oversampling->reset();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        if (tripped[channel])
+        {
+            buffer.clear (channel, 0, numSamples);
+            resetChannelState (channel);
+            formantBank.reset (channel);
+            hot.fadeInRemaining[channel] = fadeInLength;
+            stateResetCount.fetch_add (1, std::memory_order_relaxed);
+        }
+        else if (resetOversampler)
+        {
+            const float startGain = 1.0f - (float) hot.fadeInRemaining[channel] / (float) fadeInLength;
+            buffer.applyGainRamp (channel, 0, numSamples, startGain, 0.0f);
+            hot.fadeInRemaining[channel] = fadeInLength;
+        }
+        else if (hot.fadeInRemaining[channel] > 0)
+        {
+            const int n = juce::jmin (numSamples, hot.fadeInRemaining[channel]);
+            const float startGain = 1.0f - (float) hot.fadeInRemaining[channel] / (float) fadeInLength;
+            hot.fadeInRemaining[channel] -= n;
+            const float endGain = 1.0f - (float) hot.fadeInRemaining[channel] / (float) fadeInLength;
+            buffer.applyGainRamp (channel, 0, n, startGain, endGain);
+        }
+    }
+
+    updateQualityTier (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - callbackStart),
+                       numSamples);
+}
+
+//==============================================================================
+void ZDFAudioProcessor::setQualityTier (QualityTier newTier) noexcept
+{
+    qualityTier.store (newTier, std::memory_order_relaxed);
+    samplesSinceTierChange = 0;
+
+//    Exact tanh for standard/offline, the rational fit for economy - crossfaded rather than switched
+    saturation.fadeTo (newTier == QualityTier::economy ? 0.0 : 1.0,
+                       juce::jmax (1, (int) (tierCrossfadeSeconds * sr * oversamplingFactor)));
+}
+
+void ZDFAudioProcessor::updateQualityTier (double callbackSeconds, int numSamples) noexcept
+{
+//    Offline renders stay on the offline tier - there is no deadline to miss
+    if (isNonRealtime() || numSamples == 0)
+        return;
+
+//    Share of the block deadline this instance used, smoothed over roughly ten callbacks
+    const double load = callbackSeconds * sr / (double) numSamples;
+    const double smoothed = cpuLoad.load (std::memory_order_relaxed) + 0.1 * (load - cpuLoad.load (std::memory_order_relaxed));
+    cpuLoad.store ((float) smoothed, std::memory_order_relaxed);
+    samplesSinceTierChange += numSamples;
+
+//    Hysteresis: step down as soon as the budget is exceeded (after a short settle), only step back up once
+//    well under it and after a longer hold, so a borderline load can't flip the tier back and forth
+    const double budget = cpuBudgetParam->load() * 0.01;
+    const auto tier = qualityTier.load (std::memory_order_relaxed);
+
+    if (tier == QualityTier::standard && smoothed > budget
+         && samplesSinceTierChange > (juce::int64) (tierStepDownHoldSeconds * sr))
+        setQualityTier (QualityTier::economy);
+    else if (tier == QualityTier::economy && smoothed < budget * tierStepUpFraction
+              && samplesSinceTierChange > (juce::int64) (tierStepUpHoldSeconds * sr))
+        setQualityTier (QualityTier::standard);
+}
+
+//==============================================================================
+void ZDFAudioProcessor::processSerial (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                                       const Saturation& saturation) noexcept
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+
 //    Loop through the channels to generate current sample per-channel
     for (int channel = 0; channel < numChannels; ++channel)
     {
         float* data = buffer.getWritePointer(channel);
 //    Set the LP filter values based on prior states from the channel's most recent sample
-        double& vP  = vPrev[channel];
-        double& xP  = xPrev[channel];
-        double& vP2 = vPrev2[channel];
-        double& xP2 = xPrev2[channel];
+        ChannelState& st = hot.channels[channel];
+        double& vP  = st.vPrev;
+        double& xP  = st.xPrev;
+        double& vP2 = st.vPrev2;
+        double& xP2 = st.xPrev2;
         
         // HP states
-        double& vHpP = vHP[channel];
-        double& xHpP = xHP[channel];
+        double& vHpP = st.vHP;
+        double& xHpP = st.xHP;
+        Saturation drive = saturation;
 
         for (int i = 0; i < numSamples; ++i)
         {
@@ -210,8 +508,7 @@ void ZDFAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mi
             // Now produce high-pass output
             double hpOutput = x - vHP_next;
             
-            double driveGain = std::pow(10.0, driveParam * 0.5);
-            double drivenHP = std::tanh(driveGain * hpOutput);
+            double drivenHP = drive (hpOutput);
             
 
             // Compute E and F - the "right hand sides" of the discretized filter equations
@@ -245,6 +542,340 @@ void ZDFAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::Mi
     }
 }
 
+//==============================================================================
+void ZDFAudioProcessor::updateUnrolledCoefficients (double a, double R, double aHP) noexcept
+{
+    auto& k = unrolled;
+
+    constexpr int paddedLength = unrollRegisters * (int) VecD::size();
+    alignas (VecD) double lanes[paddedLength] = {};
+    auto load = [] (VecD* dest, const double* laneValues)
+    {
+        for (int r = 0; r < unrollRegisters; ++r)
+            dest[r] = VecD::fromRawArray (laneValues + r * (int) VecD::size());
+    };
+
+//    --- HP one-pole: lane j of the output is v[n+j] ---
+    if (aHP != k.aHP)
+    {
+        k.aHP = aHP;
+        k.hpG = (1.0 - aHP) / (1.0 + aHP);
+        k.hpBeta = aHP / (1.0 + aHP);
+
+        for (int j = 0; j < unrollLength; ++j)
+            lanes[j] = std::pow (k.hpG, j + 1);
+        load (k.hpFromState, lanes);
+
+        for (int i = 0; i < unrollLength; ++i)
+        {
+            for (int j = 0; j < paddedLength; ++j)
+                lanes[j] = (j >= i && j < unrollLength) ? std::pow (k.hpG, j - i) * k.hpBeta : 0.0;
+            load (k.hpFromInput[i], lanes);
+        }
+    }
+
+//    The 2-pole tables are the ones that move with keytracking/envelopes, so they're rebuilt on their own
+    if (a == k.a && R == k.R)
+        return;
+
+    k.a = a;
+    k.R = R;
+
+//    --- 2-pole: s[n] = M^-1 (N s[n-1] + [a u[n], 0]), M and N as in processParallelInTime ---
+    const double Det = (1.0 + a) * (1.0 + a) - a * a * R;
+    k.phi = { ((1.0 + a) * (1.0 - a) + a * R * a) / Det,  (a * R * (1.0 - a)) / Det,
+              (a * (1.0 - a) + (1.0 + a) * a) / Det,       ((1.0 + a) * (1.0 - a)) / Det };
+    k.b1 = (1.0 + a) * a / Det;
+    k.b2 = a * a / Det;
+
+//    powers[m] = Phi^m, markov[m] = Phi^m b
+    Matrix2 powers[unrollLength + 1];
+    powers[0] = { 1.0, 0.0, 0.0, 1.0 };
+    for (int m = 1; m <= unrollLength; ++m)
+        powers[m] = powers[m - 1] * k.phi;
+    k.phiN = powers[unrollLength];
+
+    double markov1[unrollLength], markov2[unrollLength];
+    for (int m = 0; m < unrollLength; ++m)
+    {
+        markov1[m] = powers[m].m00 * k.b1 + powers[m].m01 * k.b2;
+        markov2[m] = powers[m].m10 * k.b1 + powers[m].m11 * k.b2;
+    }
+
+    std::fill (std::begin (lanes), std::end (lanes), 0.0);
+    for (int j = 0; j < unrollLength; ++j)
+        lanes[j] = powers[j + 1].m10;
+    load (k.lpFromV1, lanes);
+
+    for (int j = 0; j < unrollLength; ++j)
+        lanes[j] = powers[j + 1].m11;
+    load (k.lpFromV2, lanes);
+
+    for (int i = 0; i < unrollLength; ++i)
+    {
+        for (int j = 0; j < paddedLength; ++j)
+            lanes[j] = (j >= i && j < unrollLength) ? markov2[j - i] : 0.0;
+        load (k.lpFromInput[i], lanes);
+
+        k.v1FromInput[i] = markov1[unrollLength - 1 - i];
+    }
+}
+
+void ZDFAudioProcessor::processUnrolled (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                                         const Saturation& saturation) noexcept
+{
+    updateUnrolledCoefficients (a, R, aHP);
+    const auto& k = unrolled;
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+    if (numSamples == 0)
+        return;
+
+    double* hp = unrolledScratch.data();
+    double* u  = unrolledScratch.data() + unrolledCapacity;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* data = buffer.getWritePointer(channel);
+        ChannelState& st = hot.channels[channel];
+        alignas (VecD) double out[unrollRegisters * VecD::size()];
+
+//        --- Pass 1: HP one-pole ---
+        double v = st.vHP;
+        double xPrev = st.xHP;
+        int i = 0;
+        for (; i + unrollLength <= numSamples; i += unrollLength)
+        {
+            VecD acc[unrollRegisters];
+            for (int r = 0; r < unrollRegisters; ++r)
+                acc[r] = k.hpFromState[r] * v;
+
+            for (int j = 0; j < unrollLength; ++j)
+            {
+                const double w = (double) data[i + j] + (j == 0 ? xPrev : (double) data[i + j - 1]);
+                for (int r = 0; r < unrollRegisters; ++r)
+                    acc[r] += k.hpFromInput[j][r] * w;
+            }
+
+            for (int r = 0; r < unrollRegisters; ++r)
+                acc[r].copyToRawArray (out + r * (int) VecD::size());
+
+            for (int j = 0; j < unrollLength; ++j)
+                hp[i + j] = (double) data[i + j] - out[j];
+
+            v = out[unrollLength - 1];
+            xPrev = (double) data[i + unrollLength - 1];
+        }
+        for (; i < numSamples; ++i)
+        {
+            const double x = (double) data[i];
+            v = k.hpG * v + k.hpBeta * (x + xPrev);
+            hp[i] = x - v;
+            xPrev = x;
+        }
+        st.vHP = v;
+        st.xHP = xPrev;
+
+//        --- Pass 2: drive, folded into the 2-pole input u[n] = drivenHP[n] + hpOutput[n-1] ---
+        Saturation drive = saturation;
+        u[0] = drive (hp[0]) + st.xPrev;
+        for (i = 1; i < numSamples; ++i)
+            u[i] = drive (hp[i]) + hp[i - 1];
+
+//        --- Pass 3: 2-pole ---
+        double s1 = st.vPrev, s2 = st.vPrev2;
+        i = 0;
+        for (; i + unrollLength <= numSamples; i += unrollLength)
+        {
+            VecD acc[unrollRegisters];
+            for (int r = 0; r < unrollRegisters; ++r)
+                acc[r] = k.lpFromV1[r] * s1 + k.lpFromV2[r] * s2;
+
+            double nextV1 = k.phiN.m00 * s1 + k.phiN.m01 * s2;
+            for (int j = 0; j < unrollLength; ++j)
+            {
+                for (int r = 0; r < unrollRegisters; ++r)
+                    acc[r] += k.lpFromInput[j][r] * u[i + j];
+                nextV1 += k.v1FromInput[j] * u[i + j];
+            }
+
+            for (int r = 0; r < unrollRegisters; ++r)
+                acc[r].copyToRawArray (out + r * (int) VecD::size());
+
+            for (int j = 0; j < unrollLength; ++j)
+                data[i + j] = (float) out[j];
+
+            s1 = nextV1;
+            s2 = out[unrollLength - 1];
+        }
+        for (; i < numSamples; ++i)
+        {
+            const double n1 = k.phi.m00 * s1 + k.phi.m01 * s2 + k.b1 * u[i];
+            const double n2 = k.phi.m10 * s1 + k.phi.m11 * s2 + k.b2 * u[i];
+            s1 = n1;
+            s2 = n2;
+            data[i] = (float) s2;
+        }
+
+        st.vPrev = s1;
+        st.vPrev2 = s2;
+        st.xPrev = hp[numSamples - 1];
+        st.xPrev2 = s1;
+    }
+}
+
+//==============================================================================
+// Parallel-in-time rendering of one block.
+//
+// The chain is linear HP -> memoryless tanh -> linear 2-pole, so each linear stage is run as its own pass:
+//   1. every chunk runs the stage from zero state (chunks in parallel),
+//   2. the true state at each chunk start is found serially by hopping over the chunks with the transition
+//      matrix raised to the chunk length: s[k+1] = Phi^L s[k] + zeroStateEnd[k],
+//   3. every chunk adds the free response Phi^n s[k] of that start state back in (chunks in parallel).
+// tanh sits between the two stages on fully corrected HP output, so the nonlinearity sees exactly what the
+// serial path feeds it. Coefficients are constant over a block, so the result matches processSerial up to rounding.
+void ZDFAudioProcessor::processParallelInTime (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                                               const Saturation& saturation, int numChunks)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+    const int chunkLength = (numSamples + numChunks - 1) / numChunks;
+    const int numTasks = numChannels * numChunks;
+
+    auto chunkStart = [=] (int k) { return k * chunkLength; };
+    auto chunkEnd   = [=] (int k) { return juce::jmin (numSamples, (k + 1) * chunkLength); };
+
+    // HP one-pole: v[n] = g v[n-1] + (input terms), so its free response is just powers of g
+    const double g = (1.0 - aHP) / (1.0 + aHP);
+
+    // 2-pole: M s[n] = N s[n-1] + [a u[n], 0] with u[n] = drivenHP[n] + hpOutput[n-1]
+    //   M = [[1+a, -aR], [-a, 1+a]], N = [[1-a, 0], [a, 1-a]], Phi = M^-1 N
+    const double Det = (1.0 + a) * (1.0 + a) - a * a * R;
+    const Matrix2 phi { ((1.0 + a) * (1.0 - a) + a * R * a) / Det,  (a * R * (1.0 - a)) / Det,
+                        (a * (1.0 - a) + (1.0 + a) * a) / Det,       ((1.0 + a) * (1.0 - a)) / Det };
+
+    auto hpOf  = [this] (int channel) { return offlineScratch.data() + (size_t) (2 * channel)     * (size_t) offlineBlockCapacity; };
+    auto outOf = [this] (int channel) { return offlineScratch.data() + (size_t) (2 * channel + 1) * (size_t) offlineBlockCapacity; };
+    auto chunkOf = [this, numChunks] (int channel, int k) -> ChunkBoundary& { return offlineChunks[(size_t) (channel * numChunks + k)]; };
+
+    auto& pool = *offlinePool.value();
+
+//    Channel pointers are fetched once here: getWritePointer writes the buffer's isClear flag, so calling it
+//    from the pool threads would race
+    float* const* channelData = buffer.getArrayOfWritePointers();
+
+//    --- Pass 1: HP from zero state ---
+    pool.parallelFor (offlineBatch, numTasks, [&] (int task)
+    {
+        const int channel = task / numChunks, k = task % numChunks;
+        const float* x = channelData[channel];
+        double* hp = hpOf (channel);
+
+        double v = 0.0;
+        double xPrev = k == 0 ? hot.channels[channel].xHP : (double) x[chunkStart (k) - 1];
+        for (int i = chunkStart (k); i < chunkEnd (k); ++i)
+        {
+            v = (v*(1.0 - aHP) + aHP*((double) x[i] + xPrev)) / (1.0 + aHP);
+            xPrev = (double) x[i];
+            hp[i] = xPrev - v;
+        }
+        chunkOf (channel, k).hpEnd = v;
+    });
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        double vStart = hot.channels[channel].vHP;
+        for (int k = 0; k < numChunks; ++k)
+        {
+            chunkOf (channel, k).hpStart = vStart;
+            vStart = std::pow (g, chunkEnd (k) - chunkStart (k)) * vStart + chunkOf (channel, k).hpEnd;
+        }
+        hot.channels[channel].vHP = vStart;
+        hot.channels[channel].xHP = (double) buffer.getSample (channel, numSamples - 1);
+    }
+
+//    --- Pass 2: HP free response, then the drive stage on the finished HP output ---
+    pool.parallelFor (offlineBatch, numTasks, [&] (int task)
+    {
+        const int channel = task / numChunks, k = task % numChunks;
+        double* hp = hpOf (channel);
+        double* out = outOf (channel);
+
+        Saturation drive = saturation; // never mid-crossfade here, so every chunk can start from the same copy
+        double vFree = chunkOf (channel, k).hpStart;
+        for (int i = chunkStart (k); i < chunkEnd (k); ++i)
+        {
+            vFree *= g;
+            hp[i] -= vFree;
+            out[i] = drive (hp[i]);
+        }
+    });
+
+//    --- Pass 3: 2-pole from zero state (out[] holds drivenHP on the way in, the zero-state output on the way out) ---
+    pool.parallelFor (offlineBatch, numTasks, [&] (int task)
+    {
+        const int channel = task / numChunks, k = task % numChunks;
+        const double* hp = hpOf (channel);
+        double* out = outOf (channel);
+
+        double vP = 0.0, vP2 = 0.0;
+        double xP = k == 0 ? hot.channels[channel].xPrev : hp[chunkStart (k) - 1];
+        for (int i = chunkStart (k); i < chunkEnd (k); ++i)
+        {
+            const double E = vP * (1.0 - a) + a * (out[i] + xP);
+            const double F = vP2*(1.0 - a) + a*(vP);
+            const double v1 = (E*(1.0 + a) + a*R*F) / Det;
+            const double v2 = ((1.0 + a)*F + a*E) / Det;
+            out[i] = v2;
+            vP = v1;
+            vP2 = v2;
+            xP = hp[i];
+        }
+        chunkOf (channel, k).v1End = vP;
+        chunkOf (channel, k).v2End = vP2;
+    });
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        ChannelState& st = hot.channels[channel];
+        double s1 = st.vPrev, s2 = st.vPrev2;
+        for (int k = 0; k < numChunks; ++k)
+        {
+            auto& chunk = chunkOf (channel, k);
+            chunk.v1Start = s1;
+            chunk.v2Start = s2;
+            const Matrix2 phiL = phi.power (chunkEnd (k) - chunkStart (k));
+            const double n1 = phiL.m00 * s1 + phiL.m01 * s2 + chunk.v1End;
+            const double n2 = phiL.m10 * s1 + phiL.m11 * s2 + chunk.v2End;
+            s1 = n1;
+            s2 = n2;
+        }
+        st.vPrev = s1;
+        st.vPrev2 = s2;
+        st.xPrev = hpOf (channel)[numSamples - 1];
+        st.xPrev2 = s1;
+    }
+
+//    --- Pass 4: 2-pole free response, written back to the host buffer ---
+    pool.parallelFor (offlineBatch, numTasks, [&] (int task)
+    {
+        const int channel = task / numChunks, k = task % numChunks;
+        const double* out = outOf (channel);
+        float* data = channelData[channel];
+
+        double s1 = chunkOf (channel, k).v1Start, s2 = chunkOf (channel, k).v2Start;
+        for (int i = chunkStart (k); i < chunkEnd (k); ++i)
+        {
+            const double n1 = phi.m00 * s1 + phi.m01 * s2;
+            const double n2 = phi.m10 * s1 + phi.m11 * s2;
+            s1 = n1;
+            s2 = n2;
+            data[i] = (float) (out[i] + s2);
+        }
+    });
+}
+
 juce::AudioProcessorEditor* ZDFAudioProcessor::createEditor()
 {
     return new juce::GenericAudioProcessorEditor(*this);
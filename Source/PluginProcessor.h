@@ -11,6 +11,9 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "OfflineRenderPool.h"
+#include "FormantBank.h"
+#include "NoteEnvelopePool.h"
 
 //==============================================================================
 /**
@@ -56,18 +59,216 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     juce::AudioProcessorValueTreeState apvts;
 
+    // Number of times the filter state went non-finite and had to be reset (safe to read from any thread)
+    int getStateResetCount() const noexcept { return stateResetCount.load (std::memory_order_relaxed); }
+
+    // Realtime instances run standard and drop to economy when they go over the CPU budget;
+    // instances prepared for an offline render run the offline tier
+    enum class QualityTier { economy, standard, offline };
+    QualityTier getQualityTier() const noexcept { return qualityTier.load (std::memory_order_relaxed); }
+    // Smoothed share of the block deadline this instance's processBlock takes (realtime only)
+    float getCpuLoad() const noexcept { return cpuLoad.load (std::memory_order_relaxed); }
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
 private:
+    // Largest R for which the discretised 2-pole stays inside the unit circle at integrator gain a
+    static double clampResonanceForStability (double R, double a) noexcept;
+    void resetChannelState (int channel) noexcept;
+
+    // Drive stage for the current quality tier: std::tanh, a cheap rational fit, or a per-sample
+    // crossfade between the two while a tier change is in progress (so the switch can't click)
+    struct Saturation
+    {
+        double gain = 1.0;
+        double exactness = 1.0;                             // 1 = std::tanh, 0 = fastTanh
+        double step = 0.0;                                  // per-sample crossfade increment, 0 when settled
+
+        // Pade-style fit, within ~2% of tanh and exactly +-1 from |x| = 3
+        static double fastTanh (double x) noexcept
+        {
+            x = juce::jlimit (-3.0, 3.0, x);
+            return x * (27.0 + x * x) / (27.0 + 9.0 * x * x);
+        }
+
+        double operator() (double x) noexcept
+        {
+            x *= gain;
+            if (step == 0.0)
+                return exactness >= 1.0 ? std::tanh (x) : fastTanh (x);
+
+            exactness = juce::jlimit (0.0, 1.0, exactness + step);
+            const double fast = fastTanh (x);
+            return fast + exactness * (std::tanh (x) - fast);
+        }
+
+        bool isCrossfading() const noexcept { return step != 0.0; }
+
+        void fadeTo (double target, int numSamples) noexcept
+        {
+            step = (target - exactness) / (double) numSamples;
+        }
+
+        // Keeps the stored copy in line with what the kernels' copies did over numSamples
+        void advance (int numSamples) noexcept
+        {
+            if (step == 0.0)
+                return;
+
+            exactness = juce::jlimit (0.0, 1.0, exactness + step * numSamples);
+            if (exactness == 0.0 || exactness == 1.0)
+                step = 0.0;
+        }
+    };
+
+    void setQualityTier (QualityTier newTier) noexcept;
+    void updateQualityTier (double callbackSeconds, int numSamples) noexcept;
+
+    // Runs the main filter over one stretch of samples with a fixed set of parameter values
+    // (not noexcept: queueing the offline helper jobs can still allocate inside juce::ThreadPool)
+    void processFilterSegment (juce::AudioBuffer<float>& buffer, float currentCutoff, float param,
+                               float hpCutoff, float drive);
+
+    // Sample-by-sample reference path - needs no scratch, so it takes blocks larger than prepareToPlay promised
+    void processSerial (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                        const Saturation& saturation) noexcept;
+    // Offline-only: same result as processSerial, with the block split into chunks rendered on the shared pool
+    void processParallelInTime (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                                const Saturation& saturation, int numChunks);
+
+    // Realtime default: HP, drive and 2-pole as three passes per channel, with both linear stages advanced
+    // unrollLength samples per iteration through precomputed transition-matrix powers (see UnrolledCoefficients)
+    void processUnrolled (juce::AudioBuffer<float>& buffer, double a, double R, double aHP,
+                          const Saturation& saturation) noexcept;
+    void updateUnrolledCoefficients (double a, double R, double aHP) noexcept;
+
+    // 2x2 state-transition matrix for the linear 2-pole (row-major)
+    struct Matrix2
+    {
+        double m00, m01, m10, m11;
+
+        Matrix2 operator* (const Matrix2& o) const noexcept
+        {
+            return { m00 * o.m00 + m01 * o.m10,  m00 * o.m01 + m01 * o.m11,
+                     m10 * o.m00 + m11 * o.m10,  m10 * o.m01 + m11 * o.m11 };
+        }
+
+        // this^n by repeated squaring
+        Matrix2 power (int n) const noexcept
+        {
+            Matrix2 result { 1.0, 0.0, 0.0, 1.0 }, base = *this;
+            for (; n > 0; n >>= 1, base = base * base)
+                if (n & 1)
+                    result = result * base;
+            return result;
+        }
+    };
+
     double sr = 44100.0;
     double wc = 2.0 * juce::MathConstants<double>::pi * 1000.0;
 
-    double vPrev[2] = {0.0, 0.0};
-    double xPrev[2] = {0.0, 0.0};
+    // Cached once in the constructor so processBlock doesn't do a lookup by ID per parameter per block
+    std::atomic<float>* cutoffParam    = nullptr;
+    std::atomic<float>* resonanceParam = nullptr;
+    std::atomic<float>* hpCutoffParam  = nullptr;
+    std::atomic<float>* driveParam     = nullptr;
+    std::atomic<float>* vowelParam     = nullptr;
+    std::atomic<float>* formantMixParam = nullptr;
+    std::atomic<float>* keytrackParam   = nullptr;
+    std::atomic<float>* envAmountParam  = nullptr;
+    std::atomic<float>* envAttackParam  = nullptr;
+    std::atomic<float>* envDecayParam   = nullptr;
+    std::atomic<float>* envSustainParam = nullptr;
+    std::atomic<float>* envReleaseParam = nullptr;
+    std::atomic<float>* cpuBudgetParam  = nullptr;
+
+    // Filter memory for one channel: the two LP integrators and the HP one-pole
+    struct ChannelState
+    {
+        double vPrev  = 0.0, xPrev  = 0.0;  // first LP stage
+        double vPrev2 = 0.0, xPrev2 = 0.0;  // second LP stage
+        double vHP    = 0.0, xHP    = 0.0;  // previous HP output / input
+    };
+
+    // Everything processBlock reads and writes per sample, kept together so that each instance touches
+    // as few cache lines as possible when hundreds of them run per callback. Deliberately not alignas (64):
+    // over-aligning the processor would need C++17 aligned operator new, which older macOS targets lack.
+    struct HotState
+    {
+        ChannelState channels[2];
+        int fadeInRemaining[2] = {0, 0}; // NaN/Inf guard: samples of fade-in left after a state reset
+    };
+
+    HotState hot;
+
+    // Block-unrolled linear core. For a recurrence s[n] = Phi s[n-1] + b u[n] with output y = c.s, the next
+    // unrollLength outputs are y[n+j] = c Phi^(j+1) s[n-1] + sum_i c Phi^(j-i) b u[n+i] - one SIMD
+    // multiply-add per term with j running across the lanes. Rebuilt only when a, R or aHP change.
+    using VecD = juce::dsp::SIMDRegister<double>;
+    static constexpr int unrollLength = 4;
+    static constexpr int unrollRegisters = (int) ((unrollLength + VecD::size() - 1) / VecD::size());
+
+    struct UnrolledCoefficients
+    {
+        double a = -1.0, R = 0.0, aHP = -1.0;               // what the tables below were built for
+
+        // HP one-pole (state v, input x[n] + x[n-1]): v[n] = g v[n-1] + beta (x[n] + x[n-1])
+        double hpG = 0.0, hpBeta = 0.0;
+        VecD hpFromState[unrollRegisters];
+        VecD hpFromInput[unrollLength][unrollRegisters];
+
+        // 2-pole (state v1, v2, input drivenHP[n] + hpOutput[n-1]): output lanes are v2
+        Matrix2 phi {}, phiN {};                            // Phi and Phi^unrollLength
+        double b1 = 0.0, b2 = 0.0;                          // input vector b
+        VecD lpFromV1[unrollRegisters], lpFromV2[unrollRegisters];
+        VecD lpFromInput[unrollLength][unrollRegisters];
+        double v1FromInput[unrollLength] = {};              // v1 at the end of an iteration
+    };
+
+    UnrolledCoefficients unrolled;
+    int unrolledCapacity = 0;
+    std::vector<double> unrolledScratch;                    // HP output, then 2-pole input, for one channel
+    int fadeInLength = 441;
+    std::atomic<int> stateResetCount { 0 };
+
+    // Parallel-in-time offline rendering - only allocated when prepared for a non-realtime render
+    struct ChunkBoundary
+    {
+        double hpEnd = 0.0, hpStart = 0.0;                  // HP one-pole: zero-state end value, true start state
+        double v1End = 0.0, v2End = 0.0;                    // 2-pole: zero-state end state
+        double v1Start = 0.0, v2Start = 0.0;                // 2-pole: true start state
+    };
+
+    static constexpr int minOfflineChunkLength = 1024;      // below this the sync overhead eats the gain
+    std::optional<juce::SharedResourcePointer<OfflineRenderPool>> offlinePool;
+    OfflineRenderPool::Batch offlineBatch;                  // this instance's reusable helper jobs
+    int maxOfflineChunks = 1;
+    int offlineBlockCapacity = 0;
+    std::vector<double> offlineScratch;                     // per channel: HP output, then drive/2-pole output
+    std::vector<ChunkBoundary> offlineChunks;               // [channel * numChunks + chunk]
+    float lastParamValues[4] = {};                          // to spot automation between blocks
+
+    // Vowel/formant bank, run in series after the main filter. Skipped entirely while its mix is at 0.
+    FormantBank formantBank;
+    bool formantActive = false;
+
+    // MIDI keytracking and per-note cutoff envelopes
+    static constexpr int modulationInterval = 32;           // max samples between cutoff updates while modulating
+    NoteEnvelopePool noteEnvelopes;
 
-    double vPrev2[2] = {0.0, 0.0};
-    double xPrev2[2] = {0.0, 0.0};
-    
-    double vHP[2] = {0.0, 0.0}; // previous HP output per channel
-    double xHP[2] = {0.0, 0.0}; // previous HP input per channel
+    // Quality tiers
+    static constexpr int offlineOversamplingOrder = 2;      // 4x for bounces
+    static constexpr double tierCrossfadeSeconds = 0.05;    // saturation crossfade on a tier change
+    static constexpr double tierStepDownHoldSeconds = 0.25; // minimum time on a tier before stepping down...
+    static constexpr double tierStepUpHoldSeconds = 3.0;    // ...and before stepping back up
+    static constexpr double tierStepUpFraction = 0.5;       // step up only below this share of the budget
+    std::atomic<QualityTier> qualityTier { QualityTier::standard };
+    std::atomic<float> cpuLoad { 0.0f };
+    juce::int64 samplesSinceTierChange = 0;
+    Saturation saturation;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;   // only while prepared for an offline render
+    int oversamplingFactor = 1;
+    int oversamplingBlockSize = 0;                          // largest block the oversampler was prepared for
 
 
     //==============================================================================